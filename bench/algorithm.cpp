@@ -0,0 +1,112 @@
+// Scaling of mj::filter, mj::group_by and mj::reduce from 1 to N threads,
+// against hand-written single-threaded loops over the same batch.
+// Usage: bench_algorithm [max threads (default: hardware concurrency)]
+
+#include "../include/explicit_type.hpp"
+#include "../include/type_tuple.hpp"
+#include "../include/type_tuple_algorithm.hpp"
+#include "bench.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using tenant_id = mj::explicit_type< int, class tenant_id_tag >;
+using bytes_in = mj::explicit_type< long long, class bytes_in_tag >;
+using cache_size = mj::explicit_type< int, class cache_size_tag >;
+using request = mj::type_tuple< tenant_id, bytes_in, cache_size >;
+
+constexpr std::size_t records = 4000000;
+
+bool big_cache(cache_size c) { return *c > 900; }
+
+// expensive only for the first quarter of the batch
+bool skewed(cache_size c)
+{
+    if (*c >= 0)
+        return *c > 900;
+    long long x = -*c;
+    for (int i = 0; i < 200; ++i)
+        x = x * 6364136223846793005LL + 1442695040888963407LL;
+    return (x & 1) != 0;
+}
+
+bytes_in sum(bytes_in v1, bytes_in v2) { return v1 + v2; }
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::size_t max_threads = std::thread::hardware_concurrency();
+    if (argc > 1)
+        max_threads = std::strtoul(argv[1], nullptr, 10);
+    if (max_threads == 0)
+        max_threads = 1;
+
+    std::vector< request > batch;
+    batch.reserve(records);
+    for (std::size_t i = 0; i < records; ++i)
+    {
+        const int size = static_cast< int >(i * 7919 % 1000);
+        batch.emplace_back(tenant_id{ static_cast< int >(i % 64) },
+            bytes_in{ static_cast< long long >(i % 1500) },
+            cache_size{ i < records / 4 ? -size - 1 : size });
+    }
+
+    bench::report("loop filter", bench::measure_ms([&] {
+        std::vector< request > out;
+        for (const auto& r : batch)
+            if (big_cache(r.get< cache_size >()))
+                out.push_back(r);
+        bench::keep(out.size());
+    }));
+    bench::report("loop skewed filter", bench::measure_ms([&] {
+        std::vector< request > out;
+        for (const auto& r : batch)
+            if (skewed(r.get< cache_size >()))
+                out.push_back(r);
+        bench::keep(out.size());
+    }));
+    bench::report("loop group_by", bench::measure_ms([&] {
+        std::map< tenant_id, std::vector< request > > out;
+        for (const auto& r : batch)
+            out[r.get< tenant_id >()].push_back(r);
+        bench::keep(out.size());
+    }));
+    bench::report("loop reduce", bench::measure_ms([&] {
+        bytes_in total{ 0 };
+        for (const auto& r : batch)
+            total += r.get< bytes_in >();
+        bench::keep(*total);
+    }));
+
+    for (std::size_t threads = 1; threads <= max_threads; ++threads)
+    {
+        std::string name;
+        name = "filter, threads: " + std::to_string(threads);
+        bench::report(name.c_str(), bench::measure_ms([&] {
+            bench::keep(
+                mj::filter< cache_size >(batch, big_cache, threads).size());
+        }));
+        name = "skewed filter, threads: " + std::to_string(threads);
+        bench::report(name.c_str(), bench::measure_ms([&] {
+            bench::keep(
+                mj::filter< cache_size >(batch, skewed, threads).size());
+        }));
+        name = "group_by, threads: " + std::to_string(threads);
+        bench::report(name.c_str(), bench::measure_ms([&] {
+            bench::keep(mj::group_by< tenant_id >(batch, threads).size());
+        }));
+        name = "reduce, threads: " + std::to_string(threads);
+        bench::report(name.c_str(), bench::measure_ms([&] {
+            bench::keep(*mj::reduce< bytes_in >(batch, sum, threads));
+        }));
+    }
+}
@@ -0,0 +1,51 @@
+// Copyright (C) 2017 - 2019 Mariusz Jaskółka.
+//
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Helpers shared by the benchmark programs. Every bench/*.cpp is a standalone
+// program, built the same way as test/test.cpp, e.g.:
+//   g++ -std=c++17 -O2 -pthread bench/interned_string.cpp -o bench_interned
+
+#ifndef jm4r_bench_H
+#define jm4r_bench_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace bench
+{
+
+// keeps the compiler from optimizing a computed (arithmetic) value away
+template < typename T > void keep(T value)
+{
+    static volatile T sink;
+    sink = value;
+    (void)sink;
+}
+
+// best wall time of fn out of a few runs, in milliseconds
+template < typename Fn > double measure_ms(Fn fn, int runs = 5)
+{
+    double best = 1e300;
+    for (int i = 0; i < runs; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration< double, std::milli > elapsed
+            = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+inline void report(const char* name, double ms)
+{
+    std::printf("%-44s %10.2f ms\n", name, ms);
+}
+
+} // namespace bench
+
+#endif // jm4r_bench_H
@@ -0,0 +1,70 @@
+// Compares explicit_type over std::string and over mj::interned_string for
+// identifier-like fields: equality, hashing and unordered_map counting.
+
+#include "../include/explicit_type.hpp"
+#include "../include/interned_string.hpp"
+#include "../include/type_tuple.hpp"
+#include "bench.hpp"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+
+constexpr std::size_t distinct_ids = 1000;
+constexpr std::size_t records = 1000000;
+
+std::string make_id(std::size_t i)
+{
+    return "tenant-" + std::to_string(i) + "-with-a-long-enough-suffix";
+}
+
+template < typename Id > void run(const char* label)
+{
+    using record = mj::type_tuple< Id >;
+    std::vector< record > batch;
+    batch.reserve(records);
+    for (std::size_t i = 0; i < records; ++i)
+        batch.emplace_back(Id{ typename Id::value_type{
+            make_id(i * 7919 % distinct_ids) } });
+    const Id target{ typename Id::value_type{ make_id(42) } };
+
+    // fields are read through the non-const get(), which returns a
+    // reference, so the loops don't copy them
+    std::string name;
+    name = std::string{ label } + " equality";
+    bench::report(name.c_str(), bench::measure_ms([&] {
+        std::size_t matches = 0;
+        for (auto& r : batch)
+            matches += r.template get< Id >() == target;
+        bench::keep(matches);
+    }));
+
+    name = std::string{ label } + " std::hash";
+    bench::report(name.c_str(), bench::measure_ms([&] {
+        std::size_t sum = 0;
+        for (auto& r : batch)
+            sum += std::hash< Id >{}(r.template get< Id >());
+        bench::keep(sum);
+    }));
+
+    name = std::string{ label } + " unordered_map count";
+    bench::report(name.c_str(), bench::measure_ms([&] {
+        std::unordered_map< Id, std::size_t > counts;
+        for (auto& r : batch)
+            ++counts[r.template get< Id >()];
+        bench::keep(counts.size());
+    }));
+}
+
+} // namespace
+
+int main()
+{
+    run< mj::explicit_type< std::string, class string_id_tag > >("string");
+    run< mj::explicit_type< mj::interned_string, class interned_id_tag > >(
+        "interned");
+}
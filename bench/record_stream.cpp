@@ -0,0 +1,91 @@
+// Record stream write throughput, size and projected read speed, compared to
+// per-record text logging of the same records.
+
+#include "../include/explicit_type.hpp"
+#include "../include/record_stream.hpp"
+#include "../include/type_tuple.hpp"
+#include "bench.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using request_id = mj::explicit_type< long long, class request_id_tag >;
+using bytes_in = mj::explicit_type< int, class bytes_in_tag >;
+using cached = mj::explicit_type< bool, class cached_tag >;
+using latency = mj::explicit_type< double, class latency_tag >;
+using tenant = mj::explicit_type< std::string, class tenant_tag >;
+using request
+    = mj::type_tuple< request_id, bytes_in, cached, latency, tenant >;
+
+constexpr std::size_t records = 1000000;
+
+} // namespace
+
+int main()
+{
+    std::vector< request > batch;
+    batch.reserve(records);
+    for (std::size_t i = 0; i < records; ++i)
+        batch.emplace_back(request_id{ 1000000000LL + static_cast< long long >(i) },
+            bytes_in{ static_cast< int >(i * 7919 % 65536) },
+            cached{ i % 3 == 0 }, latency{ static_cast< double >(i % 997) / 7 },
+            tenant{ "tenant-" + std::to_string(i % 50) });
+
+    std::string text, binary;
+    const double text_ms = bench::measure_ms([&] {
+        std::ostringstream out;
+        for (const auto& r : batch)
+            out << *r.get< request_id >() << ' ' << *r.get< bytes_in >() << ' '
+                << *r.get< cached >() << ' ' << *r.get< latency >() << ' '
+                << *r.get< tenant >() << '\n';
+        text = out.str();
+    });
+    const double write_ms = bench::measure_ms([&] {
+        std::ostringstream out;
+        {
+            mj::record_writer< request > writer{ out };
+            for (const auto& r : batch)
+                writer.write(r);
+        }
+        binary = out.str();
+    });
+
+    const double mb = 1024.0 * 1024.0;
+    std::printf("%-44s %10.2f MB\n", "text log size", text.size() / mb);
+    std::printf("%-44s %10.2f MB\n", "record stream size", binary.size() / mb);
+    bench::report("text log write", text_ms);
+    bench::report("record stream write", write_ms);
+    std::printf("%-44s %10.2f Mrows/s\n", "record stream write throughput",
+        records / write_ms / 1000.0);
+
+    bench::report("record stream read, all fields", bench::measure_ms([&] {
+        std::istringstream in{ binary };
+        mj::record_reader< request > reader{ in };
+        std::vector< request > rows;
+        while (reader.read(rows))
+            ;
+        bench::keep(rows.size());
+    }));
+    bench::report("record stream read, bytes_in only", bench::measure_ms([&] {
+        std::istringstream in{ binary };
+        mj::record_reader< request > reader{ in };
+        std::vector< mj::type_tuple< bytes_in > > rows;
+        while (reader.read(rows))
+            ;
+        bench::keep(rows.size());
+    }));
+    bench::report("record stream read, tenant only", bench::measure_ms([&] {
+        std::istringstream in{ binary };
+        mj::record_reader< request > reader{ in };
+        std::vector< mj::type_tuple< tenant > > rows;
+        while (reader.read(rows))
+            ;
+        bench::keep(rows.size());
+    }));
+}
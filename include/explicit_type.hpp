@@ -7,259 +7,516 @@
 #ifndef jm4r_EXPLICIT_TYPE_H
 #define jm4r_EXPLICIT_TYPE_H
 
+#include <cstddef>
+#include <functional>
 #include <type_traits>
 #include <utility>
 
+#if __cplusplus >= 201703L
+#include <string>
+#include <string_view>
+#endif
+
+#if defined(__cpp_impl_three_way_comparison) \
+    && __cpp_impl_three_way_comparison >= 201907L
+#include <compare>
+#endif
+
 #if __cplusplus >= 201400L
 #define MJ_CONSTEXPR14 constexpr
 #else
 #define MJ_CONSTEXPR14
 #endif
 
+// Define MJ_FORCE_INLINE_ACCESSORS to force inlining of accessors and
+// operators even in unoptimized (-O0, sanitizer) builds.
+#if defined(MJ_FORCE_INLINE_ACCESSORS) \
+    && (defined(__GNUC__) || defined(__clang__))
+#define MJ_ALWAYS_INLINE inline __attribute__((always_inline, artificial))
+#elif defined(MJ_FORCE_INLINE_ACCESSORS) && defined(_MSC_VER)
+#define MJ_ALWAYS_INLINE __forceinline
+#else
+#define MJ_ALWAYS_INLINE
+#endif
+
+#if defined(__cpp_impl_three_way_comparison) \
+    && __cpp_impl_three_way_comparison >= 201907L
+#define MJ_THREE_WAY_COMPARISON 1
+#else
+#define MJ_THREE_WAY_COMPARISON 0
+#endif
+
 namespace mj
 {
 
+template < typename T, typename Tag > class explicit_type;
+
+namespace detail
+{
+    template < typename T > struct is_explicit_type : std::false_type
+    {
+    };
+    template < typename T, typename Tag >
+    struct is_explicit_type< explicit_type< T, Tag > > : std::true_type
+    {
+    };
+}
+
 template < typename T, typename Tag > class explicit_type
 {
 public:
     using value_type = T;
 
+private:
+    // Arithmetic values are compared as value_type, like before, so the
+    // usual arithmetic conversions never take part (e.g. -1 < 1u holds).
+    template < typename U, typename Result >
+    using comparison_result = typename std::enable_if<
+        !detail::is_explicit_type< U >::value
+            && !std::is_arithmetic< value_type >::value,
+        decltype(bool(std::declval< Result >())) >::type;
+
 public:
-    constexpr explicit_type() : value_{} {}
-    constexpr explicit explicit_type(const value_type& v) : value_(v) {}
-    constexpr explicit explicit_type(value_type&& v) noexcept(std::is_nothrow_move_constructible<T>::value) : value_{ std::move(v) } {}
+    MJ_ALWAYS_INLINE constexpr explicit_type() : value_{} {}
+    MJ_ALWAYS_INLINE constexpr explicit explicit_type(const value_type& v) : value_(v) {}
+    MJ_ALWAYS_INLINE constexpr explicit explicit_type(value_type&& v) noexcept(std::is_nothrow_move_constructible<T>::value) : value_{ std::move(v) } {}
     constexpr explicit_type(const explicit_type&) = default;
     constexpr explicit_type(explicit_type&&) noexcept(std::is_nothrow_move_constructible<T>::value) = default;
     MJ_CONSTEXPR14 explicit_type& operator=(const explicit_type&) = default;
     MJ_CONSTEXPR14 explicit_type& operator=(explicit_type&&) noexcept(std::is_nothrow_move_constructible<T>::value) = default;
-    constexpr bool operator==(explicit_type v) const { return v.value_ == value_; }
-    constexpr bool operator!=(explicit_type v) const { return v.value_ != value_; }
-
     // logical operators:
-    friend constexpr bool operator==(const value_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator==(const explicit_type& v1, const explicit_type& v2)
+    {
+        return v1.value_ == v2.value_;
+    }
+    friend MJ_ALWAYS_INLINE constexpr bool operator!=(const explicit_type& v1, const explicit_type& v2)
+    {
+        return v1.value_ != v2.value_;
+    }
+    friend MJ_ALWAYS_INLINE constexpr bool operator<(const explicit_type& v1, const explicit_type& v2)
+    {
+        return v1.value_ < v2.value_;
+    }
+    friend MJ_ALWAYS_INLINE constexpr bool operator<=(const explicit_type& v1, const explicit_type& v2)
+    {
+        return v1.value_ <= v2.value_;
+    }
+    friend MJ_ALWAYS_INLINE constexpr bool operator>(const explicit_type& v1, const explicit_type& v2)
+    {
+        return v1.value_ > v2.value_;
+    }
+    friend MJ_ALWAYS_INLINE constexpr bool operator>=(const explicit_type& v1, const explicit_type& v2)
+    {
+        return v1.value_ >= v2.value_;
+    }
+
+    friend MJ_ALWAYS_INLINE constexpr bool operator==(const value_type& v1, const explicit_type& v2)
     {
         return v1 == v2.value_;
     }
-    friend constexpr bool operator==(const explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator==(const explicit_type& v1, const value_type& v2)
     {
         return v1.value_ == v2;
     }
-    friend constexpr bool operator!=(const value_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator!=(const value_type& v1, const explicit_type& v2)
     {
         return v1 != v2.value_;
     }
-    friend constexpr bool operator!=(const explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator!=(const explicit_type& v1, const value_type& v2)
     {
         return v1.value_ != v2;
     }
-    friend constexpr bool operator<(const value_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator<(const value_type& v1, const explicit_type& v2)
     {
         return v1 < v2.value_;
     }
-    friend constexpr bool operator<(const explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator<(const explicit_type& v1, const value_type& v2)
     {
         return v1.value_ < v2;
     }
-    friend constexpr bool operator<=(const value_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator<=(const value_type& v1, const explicit_type& v2)
     {
         return v1 <= v2.value_;
     }
-    friend constexpr bool operator<=(const explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator<=(const explicit_type& v1, const value_type& v2)
     {
         return v1.value_ <= v2;
     }
-    friend constexpr bool operator>(const value_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator>(const value_type& v1, const explicit_type& v2)
     {
         return v1 > v2.value_;
     }
-    friend constexpr bool operator>(const explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator>(const explicit_type& v1, const value_type& v2)
     {
         return v1.value_ > v2;
     }
-    friend constexpr bool operator>=(const value_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator>=(const value_type& v1, const explicit_type& v2)
     {
         return v1 >= v2.value_;
     }
-    friend constexpr bool operator>=(const explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr bool operator>=(const explicit_type& v1, const value_type& v2)
     {
         return v1.value_ >= v2;
     }
 
+    // heterogeneous logical operators – for non-arithmetic value_type accept
+    // anything it compares with, so no temporary value_type is ever built:
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator==(const U& v1, const explicit_type& v2)
+        -> comparison_result< U, decltype(v1 == std::declval< const value_type& >()) >
+    {
+        return v1 == v2.value_;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator==(const explicit_type& v1, const U& v2)
+        -> comparison_result< U, decltype(std::declval< const value_type& >() == v2) >
+    {
+        return v1.value_ == v2;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator!=(const U& v1, const explicit_type& v2)
+        -> comparison_result< U, decltype(v1 != std::declval< const value_type& >()) >
+    {
+        return v1 != v2.value_;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator!=(const explicit_type& v1, const U& v2)
+        -> comparison_result< U, decltype(std::declval< const value_type& >() != v2) >
+    {
+        return v1.value_ != v2;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator<(const U& v1, const explicit_type& v2)
+        -> comparison_result< U, decltype(v1 < std::declval< const value_type& >()) >
+    {
+        return v1 < v2.value_;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator<(const explicit_type& v1, const U& v2)
+        -> comparison_result< U, decltype(std::declval< const value_type& >() < v2) >
+    {
+        return v1.value_ < v2;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator<=(const U& v1, const explicit_type& v2)
+        -> comparison_result< U, decltype(v1 <= std::declval< const value_type& >()) >
+    {
+        return v1 <= v2.value_;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator<=(const explicit_type& v1, const U& v2)
+        -> comparison_result< U, decltype(std::declval< const value_type& >() <= v2) >
+    {
+        return v1.value_ <= v2;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator>(const U& v1, const explicit_type& v2)
+        -> comparison_result< U, decltype(v1 > std::declval< const value_type& >()) >
+    {
+        return v1 > v2.value_;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator>(const explicit_type& v1, const U& v2)
+        -> comparison_result< U, decltype(std::declval< const value_type& >() > v2) >
+    {
+        return v1.value_ > v2;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator>=(const U& v1, const explicit_type& v2)
+        -> comparison_result< U, decltype(v1 >= std::declval< const value_type& >()) >
+    {
+        return v1 >= v2.value_;
+    }
+    template < typename U >
+    friend MJ_ALWAYS_INLINE constexpr auto operator>=(const explicit_type& v1, const U& v2)
+        -> comparison_result< U, decltype(std::declval< const value_type& >() >= v2) >
+    {
+        return v1.value_ >= v2;
+    }
+
+#if MJ_THREE_WAY_COMPARISON
+    friend MJ_ALWAYS_INLINE constexpr auto operator<=>(const explicit_type& v1, const explicit_type& v2)
+        requires requires(const value_type& a) { a <=> a; }
+    {
+        return v1.value_ <=> v2.value_;
+    }
+    friend MJ_ALWAYS_INLINE constexpr auto operator<=>(const explicit_type& v1, const value_type& v2)
+        requires requires(const value_type& a) { a <=> a; }
+    {
+        return v1.value_ <=> v2;
+    }
+    template < typename U >
+    requires(!detail::is_explicit_type< U >::value)
+        && (!std::is_arithmetic< value_type >::value)
+        && requires(const value_type& a, const U& b) { a <=> b; }
+    friend MJ_ALWAYS_INLINE constexpr auto operator<=>(const explicit_type& v1, const U& v2)
+    {
+        return v1.value_ <=> v2;
+    }
+#endif
+
     // arithmetic operators:
-    friend constexpr explicit_type operator+(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator+(
         const explicit_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1.value_ + v2.value_ };
     }
-    friend constexpr explicit_type operator-(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator-(
         const explicit_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1.value_ - v2.value_ };
     }
-    friend constexpr explicit_type operator*(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator*(
         const value_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1 * v2.value_ };
     }
-    friend constexpr explicit_type operator*(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator*(
         const explicit_type& v1, const value_type& v2)
     {
         return explicit_type{ v1.value_ * v2 };
     }
-    friend constexpr explicit_type operator/(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator/(
         const explicit_type& v1, const value_type& v2)
     {
         return explicit_type{ v1.value_ / v2 };
     }
-    friend constexpr value_type operator/(
+    friend MJ_ALWAYS_INLINE constexpr value_type operator/(
         const explicit_type& v1, const explicit_type& v2)
     {
         return v1.value_ / v2.value_;
     }
-    friend constexpr value_type operator%(const explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE constexpr value_type operator%(const explicit_type& v1, const value_type& v2)
     {
         return value_type{ v1.value_ % v2 };
     }
 
     // bit operators:
-    friend constexpr explicit_type operator<<(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator<<(
         const explicit_type& v1, const value_type& v2)
     {
         return explicit_type{ v1.value_ << v2 };
     }
-    friend constexpr explicit_type operator<<(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator<<(
         const explicit_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1.value_ << v2.value_ };
     }
-    friend constexpr explicit_type operator>>(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator>>(
         const explicit_type& v1, const value_type& v2)
     {
         return explicit_type{ v1.value_ >> v2 };
     }
-    friend constexpr explicit_type operator>>(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator>>(
         const explicit_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1.value_ >> v2.value_ };
     }
-    friend constexpr explicit_type operator&(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator&(
         const explicit_type& v1, const value_type& v2)
     {
         return explicit_type{ v1.value_ & v2 };
     }
-    friend constexpr explicit_type operator&(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator&(
         const value_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1 & v2.value_ };
     }
-    friend constexpr explicit_type operator&(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator&(
         const explicit_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1.value_ & v2.value_ };
     }
-    friend constexpr explicit_type operator|(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator|(
         const explicit_type& v1, const value_type& v2)
     {
         return explicit_type{ v1.value_ | v2 };
     }
-    friend constexpr explicit_type operator|(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator|(
         const value_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1 | v2.value_ };
     }
-    friend constexpr explicit_type operator|(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator|(
         const explicit_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1.value_ | v2.value_ };
     }
-    friend constexpr explicit_type operator^(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator^(
         const explicit_type& v1, const value_type& v2)
     {
         return explicit_type{ v1.value_ ^ v2 };
     }
-    friend constexpr explicit_type operator^(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator^(
         const value_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1 ^ v2.value_ };
     }
-    friend constexpr explicit_type operator^(
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator^(
         const explicit_type& v1, const explicit_type& v2)
     {
         return explicit_type{ v1.value_ ^ v2.value_ };
     }
 
     // one argument operators:
-    friend constexpr explicit_type operator~(const explicit_type& v1)
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator~(const explicit_type& v1)
     {
         return explicit_type{ ~v1.value_ };
     }
-    friend constexpr explicit_type operator!(const explicit_type& v1)
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator!(const explicit_type& v1)
     {
         return explicit_type{ !v1.value_ };
     }
-    friend constexpr explicit_type operator+(const explicit_type& v1)
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator+(const explicit_type& v1)
     {
         return explicit_type{ +v1.value_ };
     }
-    friend constexpr explicit_type operator-(const explicit_type& v1)
+    friend MJ_ALWAYS_INLINE constexpr explicit_type operator-(const explicit_type& v1)
     {
         return explicit_type{ -v1.value_ };
     }
 
     // mutating operators:
-    friend MJ_CONSTEXPR14 void operator+=(explicit_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator+=(explicit_type& v1, const explicit_type& v2)
     {
         v1.value_ += v2.value_;
     }
-    friend MJ_CONSTEXPR14 void operator-=(explicit_type& v1, const explicit_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator-=(explicit_type& v1, const explicit_type& v2)
     {
         v1.value_ -= v2.value_;
     }
-    friend MJ_CONSTEXPR14 void operator*=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator*=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ *= v2;
     }
-    friend MJ_CONSTEXPR14 void operator/=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator/=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ /= v2;
     }
-    friend MJ_CONSTEXPR14 void operator%=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator%=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ %= v2;
     }
-    friend MJ_CONSTEXPR14 void operator<<=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator<<=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ <<= v2;
     }
-    friend MJ_CONSTEXPR14 void operator>>=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator>>=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ >>= v2;
     }
-    friend MJ_CONSTEXPR14 void operator&=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator&=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ &= v2;
     }
-    friend MJ_CONSTEXPR14 void operator|=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator|=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ |= v2;
     }
-    friend MJ_CONSTEXPR14 void operator^=(explicit_type& v1, const value_type& v2)
+    friend MJ_ALWAYS_INLINE MJ_CONSTEXPR14 void operator^=(explicit_type& v1, const value_type& v2)
     {
         v1.value_ ^= v2;
     }
 
-    constexpr explicit operator value_type() const { return value_; }
-    constexpr const value_type* operator->() const& { return &value_; }
-    value_type* operator->() & { return &value_; }
+    MJ_ALWAYS_INLINE constexpr explicit operator value_type() const { return value_; }
+    MJ_ALWAYS_INLINE constexpr const value_type* operator->() const& { return &value_; }
+    MJ_ALWAYS_INLINE value_type* operator->() & { return &value_; }
 
-    constexpr const value_type& operator*() const& { return value_; }
-    value_type& operator*() & { return value_; }
+    MJ_ALWAYS_INLINE constexpr const value_type& operator*() const& { return value_; }
+    MJ_ALWAYS_INLINE value_type& operator*() & { return value_; }
 
 private:
     value_type value_;
 };
+
+namespace detail
+{
+    template < typename T > struct value_hash : std::hash< T >
+    {
+    };
+
+#if __cplusplus >= 201703L
+    // strings are hashed through string_view, so string_view and character
+    // literal keys hash the same as the stored string without copying it
+    template < typename CharT, typename Traits, typename Alloc >
+    struct value_hash< std::basic_string< CharT, Traits, Alloc > >
+    {
+        std::size_t operator()(std::basic_string_view< CharT, Traits > v) const
+        {
+            return std::hash< std::basic_string_view< CharT, Traits > >{}(v);
+        }
+    };
+#endif
+}
+
+namespace detail
+{
+    // std::hash of explicit_type is enabled only when the one of value_type
+    // is; otherwise it is disabled the same way std::hash of unhashable types
+    template < typename Explicit, typename = void > struct explicit_type_hash
+    {
+        explicit_type_hash() = delete;
+        explicit_type_hash(const explicit_type_hash&) = delete;
+        explicit_type_hash& operator=(const explicit_type_hash&) = delete;
+    };
+
+    template < typename Explicit >
+    struct explicit_type_hash< Explicit,
+        decltype(void(std::hash< typename std::remove_cv<
+                typename Explicit::value_type >::type >{}(
+            std::declval< const typename Explicit::value_type& >()))) >
+    {
+        std::size_t operator()(const Explicit& v) const
+        {
+            return std::hash< typename std::remove_cv<
+                typename Explicit::value_type >::type >{}(*v);
+        }
+    };
+}
+
+// Transparent hasher for explicit_type keys of unordered containers; also
+// hashes anything Hash accepts, to allow lookups without building the key.
+template < typename Explicit,
+    typename Hash = detail::value_hash<
+        typename std::remove_cv< typename Explicit::value_type >::type > >
+struct explicit_hash
+{
+    using is_transparent = void;
+
+    std::size_t operator()(const Explicit& v) const { return Hash{}(*v); }
+
+    template < typename U,
+        typename std::enable_if< !detail::is_explicit_type< U >::value >::type* = nullptr >
+    std::size_t operator()(const U& v) const
+    {
+        return Hash{}(v);
+    }
+};
+
+// Transparent equality, counterpart of explicit_hash.
+struct explicit_equal_to
+{
+    using is_transparent = void;
+
+    template < typename T, typename U >
+    constexpr bool operator()(const T& v1, const U& v2) const
+    {
+        return v1 == v2;
+    }
+};
 } // namespace mj
 
+namespace std
+{
+template < typename T, typename Tag >
+struct hash< mj::explicit_type< T, Tag > >
+    : mj::detail::explicit_type_hash< mj::explicit_type< T, Tag > >
+{
+};
+} // namespace std
+
 #undef MJ_CONSTEXPR14
+#undef MJ_THREE_WAY_COMPARISON
+#undef MJ_ALWAYS_INLINE
 
 #endif // jm4r_EXPLICIT_TYPE_H
@@ -0,0 +1,290 @@
+// Copyright (C) 2017 - 2019 Mariusz Jaskółka.
+//
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef jm4r_INTERNED_STRING_H
+#define jm4r_INTERNED_STRING_H
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace mj
+{
+
+namespace detail
+{
+    // Process-wide pool of unique strings. Nodes of std::unordered_set are
+    // never relocated and the pool is never destroyed (not even at exit, so
+    // destructors of other statics can still use interned strings), so the
+    // addresses handed out stay valid forever.
+    class intern_table
+    {
+    public:
+        static const std::string* intern(const char* str, std::size_t len)
+        {
+            if (len == 0)
+                return nullptr;
+            intern_table& table = instance();
+            std::lock_guard< std::mutex > lock{ table.mutex_ };
+            return &*table.strings_.emplace(str, len).first;
+        }
+
+        // Pooled string with the given content, or nullptr if there is none.
+        // Never adds anything to the pool.
+        static const std::string* find(const char* str, std::size_t len)
+        {
+            if (len == 0)
+                return nullptr;
+            intern_table& table = instance();
+            std::lock_guard< std::mutex > lock{ table.mutex_ };
+            const auto it = table.strings_.find(std::string{ str, len });
+            return it == table.strings_.end() ? nullptr : &*it;
+        }
+
+        static std::size_t size()
+        {
+            intern_table& table = instance();
+            std::lock_guard< std::mutex > lock{ table.mutex_ };
+            return table.strings_.size();
+        }
+
+    private:
+        static intern_table& instance()
+        {
+            static intern_table* table = new intern_table;
+            return *table;
+        }
+
+        std::mutex mutex_;
+        std::unordered_set< std::string > strings_;
+    };
+
+    // Characters of a string which is compared with or hashed like an
+    // interned_string, without being interned.
+    struct string_ref
+    {
+        const char* data;
+        std::size_t size;
+    };
+
+    inline string_ref to_string_ref(const char* str)
+    {
+        return string_ref{ str, std::strlen(str) };
+    }
+    inline string_ref to_string_ref(const std::string& str)
+    {
+        return string_ref{ str.data(), str.size() };
+    }
+#if __cplusplus >= 201703L
+    inline string_ref to_string_ref(std::string_view str)
+    {
+        return string_ref{ str.data(), str.size() };
+    }
+#endif
+}
+
+// Immutable string stored once per distinct content. Equality and hashing
+// compare the address of the pooled string, ordering compares the content.
+// Constructors are explicit, as every constructed content stays in the pool
+// forever; comparisons with plain strings compare the content and don't
+// intern it.
+class interned_string
+{
+    template < typename S >
+    using content_comparison
+        = decltype(detail::to_string_ref(std::declval< const S& >()), bool());
+
+public:
+    constexpr interned_string() : str_{ nullptr } {}
+    explicit interned_string(const char* str)
+    : str_{ detail::intern_table::intern(str, std::strlen(str)) }
+    {
+    }
+    explicit interned_string(const std::string& str)
+    : str_{ detail::intern_table::intern(str.data(), str.size()) }
+    {
+    }
+#if __cplusplus >= 201703L
+    explicit interned_string(std::string_view str)
+    : str_{ detail::intern_table::intern(str.data(), str.size()) }
+    {
+    }
+#endif
+
+    const std::string& str() const { return str_ ? *str_ : empty_str(); }
+    const char* c_str() const { return str().c_str(); }
+    std::size_t size() const { return str_ ? str_->size() : 0; }
+    constexpr bool empty() const { return str_ == nullptr; }
+#if __cplusplus >= 201703L
+    std::string_view view() const
+    {
+        return str_ ? std::string_view{ *str_ } : std::string_view{};
+    }
+#endif
+
+    friend constexpr bool operator==(
+        const interned_string& v1, const interned_string& v2)
+    {
+        return v1.str_ == v2.str_;
+    }
+    friend constexpr bool operator!=(
+        const interned_string& v1, const interned_string& v2)
+    {
+        return v1.str_ != v2.str_;
+    }
+    friend bool operator<(const interned_string& v1, const interned_string& v2)
+    {
+        return v1.str_ != v2.str_ && v1.str() < v2.str();
+    }
+    friend bool operator<=(const interned_string& v1, const interned_string& v2)
+    {
+        return !(v2 < v1);
+    }
+    friend bool operator>(const interned_string& v1, const interned_string& v2)
+    {
+        return v2 < v1;
+    }
+    friend bool operator>=(const interned_string& v1, const interned_string& v2)
+    {
+        return !(v1 < v2);
+    }
+
+    // content comparisons with const char*, std::string and std::string_view:
+    template < typename S >
+    friend auto operator==(const interned_string& v1, const S& v2)
+        -> content_comparison< S >
+    {
+        return v1.compare(detail::to_string_ref(v2)) == 0;
+    }
+    template < typename S >
+    friend auto operator==(const S& v1, const interned_string& v2)
+        -> content_comparison< S >
+    {
+        return v2.compare(detail::to_string_ref(v1)) == 0;
+    }
+    template < typename S >
+    friend auto operator!=(const interned_string& v1, const S& v2)
+        -> content_comparison< S >
+    {
+        return v1.compare(detail::to_string_ref(v2)) != 0;
+    }
+    template < typename S >
+    friend auto operator!=(const S& v1, const interned_string& v2)
+        -> content_comparison< S >
+    {
+        return v2.compare(detail::to_string_ref(v1)) != 0;
+    }
+    template < typename S >
+    friend auto operator<(const interned_string& v1, const S& v2)
+        -> content_comparison< S >
+    {
+        return v1.compare(detail::to_string_ref(v2)) < 0;
+    }
+    template < typename S >
+    friend auto operator<(const S& v1, const interned_string& v2)
+        -> content_comparison< S >
+    {
+        return v2.compare(detail::to_string_ref(v1)) > 0;
+    }
+    template < typename S >
+    friend auto operator<=(const interned_string& v1, const S& v2)
+        -> content_comparison< S >
+    {
+        return v1.compare(detail::to_string_ref(v2)) <= 0;
+    }
+    template < typename S >
+    friend auto operator<=(const S& v1, const interned_string& v2)
+        -> content_comparison< S >
+    {
+        return v2.compare(detail::to_string_ref(v1)) >= 0;
+    }
+    template < typename S >
+    friend auto operator>(const interned_string& v1, const S& v2)
+        -> content_comparison< S >
+    {
+        return v1.compare(detail::to_string_ref(v2)) > 0;
+    }
+    template < typename S >
+    friend auto operator>(const S& v1, const interned_string& v2)
+        -> content_comparison< S >
+    {
+        return v2.compare(detail::to_string_ref(v1)) < 0;
+    }
+    template < typename S >
+    friend auto operator>=(const interned_string& v1, const S& v2)
+        -> content_comparison< S >
+    {
+        return v1.compare(detail::to_string_ref(v2)) >= 0;
+    }
+    template < typename S >
+    friend auto operator>=(const S& v1, const interned_string& v2)
+        -> content_comparison< S >
+    {
+        return v2.compare(detail::to_string_ref(v1)) <= 0;
+    }
+
+    std::size_t hash() const { return std::hash< const void* >{}(str_); }
+
+    // Hash of an interned_string with the content of str, without interning
+    // it (content which was never interned hashes like the empty string).
+    template < typename S >
+    static auto hash(const S& str)
+        -> decltype(detail::to_string_ref(str), std::size_t())
+    {
+        const detail::string_ref ref = detail::to_string_ref(str);
+        return std::hash< const void* >{}(
+            detail::intern_table::find(ref.data, ref.size));
+    }
+
+private:
+    int compare(detail::string_ref other) const
+    {
+        const std::size_t len = size();
+        const std::size_t common = len < other.size ? len : other.size;
+        const int result
+            = common ? std::memcmp(str_->data(), other.data, common) : 0;
+        if (result != 0)
+            return result;
+        return len < other.size ? -1 : len > other.size ? 1 : 0;
+    }
+
+    static const std::string& empty_str()
+    {
+        static const std::string e;
+        return e;
+    }
+
+    const std::string* str_;
+};
+
+} // namespace mj
+
+namespace std
+{
+template <> struct hash< mj::interned_string >
+{
+    std::size_t operator()(const mj::interned_string& v) const
+    {
+        return v.hash();
+    }
+    // hashes plain strings without interning them, for transparent lookups
+    template < typename S >
+    auto operator()(const S& v) const -> decltype(
+        mj::interned_string::hash(v))
+    {
+        return mj::interned_string::hash(v);
+    }
+};
+} // namespace std
+
+#endif // jm4r_INTERNED_STRING_H
@@ -0,0 +1,614 @@
+// Copyright (C) 2017 - 2019 Mariusz Jaskółka.
+//
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef jm4r_record_stream_H
+#define jm4r_record_stream_H
+
+#include "explicit_type.hpp"
+#include "type_tuple.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Stream layout (all integers and floating point values little-endian):
+//
+//   file      := header row_group*
+//   header    := "MJTT" version:u8 columns:u32 encoding:u8{columns}
+//   row_group := group_magic:u32 group_head head_fnv1a:u32 byte* group_magic:u32
+//   group_head := rows:u32 (size:u32 fnv1a:u32){columns}
+//
+// group_head describes the column chunks that follow it; it is covered by
+// its own checksum, so damaged sizes are never used. Row groups are only ever
+// appended. A group that is cut short (the writer crashed in the middle of
+// it) or fails a checksum is skipped: the reader looks for the next
+// group_magic, so groups appended after a crash stay readable too.
+
+namespace mj
+{
+
+namespace detail
+{
+    constexpr std::uint32_t record_stream_version = 1;
+    constexpr std::uint32_t row_group_magic = 0x4752544d; // "MTRG"
+    // limits guarding the reader against damaged sizes
+    constexpr std::uint32_t max_group_rows = 1u << 24;
+    constexpr std::uint32_t max_column_size = 1u << 30;
+
+    enum column_encoding : std::uint8_t
+    {
+        delta_varint = 1,
+        bitmap = 2,
+        plain = 3,
+        dictionary = 4
+    };
+
+    inline std::uint32_t fnv1a(const char* data, std::size_t size)
+    {
+        std::uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            hash ^= static_cast< unsigned char >(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    inline void put_u32(std::string& out, std::uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i)
+            out.push_back(static_cast< char >((v >> (8 * i)) & 0xff));
+    }
+
+    inline bool get_u32(const char*& first, const char* last, std::uint32_t& v)
+    {
+        if (last - first < 4)
+            return false;
+        v = 0;
+        for (int i = 0; i < 4; ++i)
+            v |= std::uint32_t{ static_cast< unsigned char >(*first++) }
+                << (8 * i);
+        return true;
+    }
+
+    inline bool get_u32(std::istream& in, std::uint32_t& v)
+    {
+        char buf[4];
+        const char* first = buf;
+        return in.read(buf, 4) && get_u32(first, buf + 4, v);
+    }
+
+    inline void put_varint(std::string& out, std::uint64_t v)
+    {
+        for (; v >= 0x80; v >>= 7)
+            out.push_back(static_cast< char >((v & 0x7f) | 0x80));
+        out.push_back(static_cast< char >(v));
+    }
+
+    inline bool get_varint(const char*& first, const char* last, std::uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; first != last && shift < 64; shift += 7)
+        {
+            const auto byte = static_cast< unsigned char >(*first++);
+            v |= std::uint64_t{ byte & 0x7fu } << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+}
+
+// Encodes one column of values of type T. Specialize for own types; the
+// id is stored in the file header to detect schema mismatch.
+template < typename T, typename = void > struct column_codec;
+
+// integers and enums: difference to the previous value, zigzag varint
+template < typename T >
+struct column_codec< T,
+    typename std::enable_if< (std::is_integral< T >::value
+                                 && !std::is_same< T, bool >::value)
+        || std::is_enum< T >::value >::type >
+{
+    static constexpr std::uint8_t id = detail::delta_varint;
+
+    static void encode(const std::vector< T >& values, std::string& out)
+    {
+        std::uint64_t prev = 0;
+        for (const T& v : values)
+        {
+            const auto cur = static_cast< std::uint64_t >(v);
+            const std::uint64_t delta = cur - prev;
+            detail::put_varint(out, (delta << 1) ^ (0 - (delta >> 63)));
+            prev = cur;
+        }
+    }
+
+    static bool decode(const char* first, const char* last, std::size_t rows,
+        std::vector< T >& values)
+    {
+        std::uint64_t prev = 0;
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            std::uint64_t zigzag;
+            if (!detail::get_varint(first, last, zigzag))
+                return false;
+            prev += (zigzag >> 1) ^ (0 - (zigzag & 1));
+            values.push_back(static_cast< T >(prev));
+        }
+        return first == last;
+    }
+};
+
+// bools: one bit per row
+template < typename T >
+struct column_codec< T,
+    typename std::enable_if< std::is_same< T, bool >::value >::type >
+{
+    static constexpr std::uint8_t id = detail::bitmap;
+
+    static void encode(const std::vector< T >& values, std::string& out)
+    {
+        const std::size_t offset = out.size();
+        out.resize(offset + (values.size() + 7) / 8);
+        for (std::size_t i = 0; i < values.size(); ++i)
+            if (values[i])
+                out[offset + i / 8] |= static_cast< char >(1 << (i % 8));
+    }
+
+    static bool decode(const char* first, const char* last, std::size_t rows,
+        std::vector< T >& values)
+    {
+        if (static_cast< std::size_t >(last - first) != (rows + 7) / 8)
+            return false;
+        for (std::size_t i = 0; i < rows; ++i)
+            values.push_back((first[i / 8] >> (i % 8)) & 1);
+        return true;
+    }
+};
+
+// floating point: IEEE 754 bits, little-endian
+template < typename T >
+struct column_codec< T,
+    typename std::enable_if< std::is_floating_point< T >::value >::type >
+{
+    static_assert(std::numeric_limits< T >::is_iec559
+            && (sizeof(T) == 4 || sizeof(T) == 8),
+        "only IEEE 754 float and double columns are supported");
+    using bits_type = typename std::conditional< sizeof(T) == 4,
+        std::uint32_t, std::uint64_t >::type;
+
+    static constexpr std::uint8_t id = detail::plain;
+
+    static void encode(const std::vector< T >& values, std::string& out)
+    {
+        for (const T& v : values)
+        {
+            bits_type bits;
+            std::memcpy(&bits, &v, sizeof(T));
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+                out.push_back(static_cast< char >((bits >> (8 * i)) & 0xff));
+        }
+    }
+
+    static bool decode(const char* first, const char* last, std::size_t rows,
+        std::vector< T >& values)
+    {
+        if (static_cast< std::size_t >(last - first) != rows * sizeof(T))
+            return false;
+        for (std::size_t row = 0; row < rows; ++row)
+        {
+            bits_type bits = 0;
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+                bits |= bits_type{ static_cast< unsigned char >(*first++) }
+                    << (8 * i);
+            T v;
+            std::memcpy(&v, &bits, sizeof(T));
+            values.push_back(v);
+        }
+        return true;
+    }
+};
+
+// strings: dictionary of distinct values followed by an index per row
+template <> struct column_codec< std::string >
+{
+    static constexpr std::uint8_t id = detail::dictionary;
+
+    static void encode(const std::vector< std::string >& values, std::string& out)
+    {
+        std::unordered_map< std::string, std::uint64_t > indices;
+        std::vector< const std::string* > dictionary;
+        std::string index_part;
+        for (const auto& v : values)
+        {
+            auto found = indices.emplace(v, dictionary.size());
+            if (found.second)
+                dictionary.push_back(&found.first->first);
+            detail::put_varint(index_part, found.first->second);
+        }
+        detail::put_varint(out, dictionary.size());
+        for (const auto* entry : dictionary)
+        {
+            detail::put_varint(out, entry->size());
+            out.append(*entry);
+        }
+        out.append(index_part);
+    }
+
+    static bool decode(const char* first, const char* last, std::size_t rows,
+        std::vector< std::string >& values)
+    {
+        std::uint64_t size;
+        if (!detail::get_varint(first, last, size))
+            return false;
+        std::vector< std::string > dictionary;
+        for (std::uint64_t i = 0; i < size; ++i)
+        {
+            std::uint64_t length;
+            if (!detail::get_varint(first, last, length)
+                || static_cast< std::uint64_t >(last - first) < length)
+                return false;
+            dictionary.emplace_back(first, static_cast< std::size_t >(length));
+            first += length;
+        }
+        for (std::size_t i = 0; i < rows; ++i)
+        {
+            std::uint64_t index;
+            if (!detail::get_varint(first, last, index)
+                || index >= dictionary.size())
+                return false;
+            values.push_back(dictionary[static_cast< std::size_t >(index)]);
+        }
+        return first == last;
+    }
+};
+
+namespace detail
+{
+    template < typename T, typename... Ts > struct index_of;
+    template < typename T, typename... Ts >
+    struct index_of< T, T, Ts... > : std::integral_constant< std::size_t, 0 >
+    {
+    };
+    template < typename T, typename U, typename... Ts >
+    struct index_of< T, U, Ts... >
+        : std::integral_constant< std::size_t, 1 + index_of< T, Ts... >::value >
+    {
+    };
+
+    template < typename Field >
+    using column_value =
+        typename std::remove_cv< typename Field::value_type >::type;
+}
+
+struct record_writer_options
+{
+    // rows buffered before a row group is written, 0 – default (65536)
+    using row_group_size = explicit_type< std::size_t, class row_group_size_tag >;
+    // continue an existing stream, so the header is not written again
+    using append = explicit_type< bool, class append_tag >;
+};
+
+template < typename Tuple > class record_writer;
+template < typename Tuple > class record_reader;
+
+// Buffers rows and writes them as row groups, each field as its own column.
+template < typename... Params > class record_writer< type_tuple< Params... > >
+{
+public:
+    using options = record_writer_options;
+    using record = type_tuple< Params... >;
+
+    template < typename... Opts >
+    explicit record_writer(std::ostream& out, Opts&&... opts) : out_(out)
+    {
+        const type_tuple< options::row_group_size, options::append > o{
+            std::forward< Opts >(opts)...
+        };
+        rows_per_group_ = *o.get< options::row_group_size >();
+        if (rows_per_group_ == 0)
+            rows_per_group_ = 65536;
+        if (rows_per_group_ > detail::max_group_rows)
+            throw std::invalid_argument{ "record_writer: row group too big" };
+        if (!*o.get< options::append >())
+            write_header();
+    }
+
+    record_writer(const record_writer&) = delete;
+    record_writer& operator=(const record_writer&) = delete;
+
+    ~record_writer()
+    {
+        try
+        {
+            flush();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    void write(const record& row)
+    {
+        using expand = int[];
+        (void)expand{ 0, push< Params >(row)... };
+        if (++rows_ == rows_per_group_)
+            flush();
+    }
+
+    // Writes buffered rows (if any) as a complete row group.
+    void flush()
+    {
+        if (rows_ == 0)
+            return;
+        std::string header, chunks;
+        detail::put_u32(header, static_cast< std::uint32_t >(rows_));
+        using expand = int[];
+        (void)expand{ 0, encode< Params >(header, chunks)... };
+
+        std::string group;
+        detail::put_u32(group, detail::row_group_magic);
+        group.append(header);
+        detail::put_u32(group, detail::fnv1a(header.data(), header.size()));
+        group.append(chunks);
+        detail::put_u32(group, detail::row_group_magic);
+
+        rows_ = 0;
+        out_.write(group.data(), static_cast< std::streamsize >(group.size()));
+        out_.flush();
+        if (!out_)
+            throw std::runtime_error{ "record_writer: write failed" };
+    }
+
+private:
+    void write_header()
+    {
+        std::string header{ "MJTT" };
+        header.push_back(static_cast< char >(detail::record_stream_version));
+        detail::put_u32(header, sizeof...(Params));
+        using expand = int[];
+        (void)expand{ 0,
+            (header.push_back(static_cast< char >(
+                 column_codec< detail::column_value< Params > >::id)),
+                0)... };
+        out_.write(header.data(), static_cast< std::streamsize >(header.size()));
+    }
+
+    template < typename P > int push(const record& row)
+    {
+        column< P >().push_back(*row.template get< P >());
+        return 0;
+    }
+
+    template < typename P > int encode(std::string& header, std::string& chunks)
+    {
+        const std::size_t offset = chunks.size();
+        column_codec< detail::column_value< P > >::encode(column< P >(), chunks);
+        column< P >().clear();
+        const std::size_t size = chunks.size() - offset;
+        if (size > detail::max_column_size)
+            throw std::length_error{ "record_writer: column chunk too big" };
+        detail::put_u32(header, static_cast< std::uint32_t >(size));
+        detail::put_u32(header, detail::fnv1a(chunks.data() + offset, size));
+        return 0;
+    }
+
+    template < typename P > std::vector< detail::column_value< P > >& column()
+    {
+        return std::get< detail::index_of< P, Params... >::value >(columns_);
+    }
+
+    std::ostream& out_;
+    std::size_t rows_per_group_;
+    std::size_t rows_ = 0;
+    std::tuple< std::vector< detail::column_value< Params > >... > columns_;
+};
+
+// Reads row groups written by record_writer. Only the requested fields are
+// decoded, other columns are skipped without being read into memory.
+template < typename... Params > class record_reader< type_tuple< Params... > >
+{
+public:
+    explicit record_reader(std::istream& in) : in_(in) { read_header(); }
+
+    // Appends rows of the next valid row group to rows. Damaged groups are
+    // skipped by scanning for the next group magic. Returns false at the end
+    // of the stream.
+    template < typename... Fields >
+    bool read(std::vector< type_tuple< Fields... > >& rows)
+    {
+        static_assert(sizeof...(Fields) > 0, "no field to read");
+        using expand = int[];
+        (void)expand{ 0, check_field< Fields >()... };
+
+        if (in_.peek() == std::char_traits< char >::eof())
+            return false;
+        std::istream::pos_type resume = in_.tellg();
+        std::uint32_t magic;
+        bool found = detail::get_u32(in_, magic)
+            && magic == detail::row_group_magic;
+        while (true)
+        {
+            if (found)
+            {
+                const std::istream::pos_type after_magic = in_.tellg();
+                if (read_group(rows))
+                    return true;
+                resume = after_magic;
+                if (resume != std::istream::pos_type(-1))
+                    resume -= 3;
+            }
+            else if (resume != std::istream::pos_type(-1))
+                resume += 1;
+            found = find_magic(resume);
+            if (!found)
+                return false;
+        }
+    }
+
+private:
+    template < typename F > static int check_field()
+    {
+        static_assert(detail::contains< F, Params... >::value,
+            "field is not stored in the stream");
+        return 0;
+    }
+
+    void read_header()
+    {
+        char magic[4];
+        std::uint32_t columns;
+        if (!in_.read(magic, 4) || std::memcmp(magic, "MJTT", 4) != 0
+            || in_.get() != static_cast< int >(detail::record_stream_version)
+            || !detail::get_u32(in_, columns))
+            throw std::runtime_error{ "record_reader: not a record stream" };
+        if (columns != sizeof...(Params))
+            throw std::runtime_error{ "record_reader: column count mismatch" };
+
+        const std::uint8_t expected[]
+            = { column_codec< detail::column_value< Params > >::id... };
+        for (auto id : expected)
+            if (in_.get() != id)
+                throw std::runtime_error{ "record_reader: column type mismatch" };
+    }
+
+    // Moves to the position after the next group magic found from resume on
+    // (or from the current position, when the stream can't seek).
+    bool find_magic(std::istream::pos_type resume)
+    {
+        in_.clear();
+        if (resume != std::istream::pos_type(-1) && !in_.seekg(resume))
+            return false;
+        std::uint32_t window = 0;
+        int seen = 0;
+        for (int c = in_.get(); c != std::char_traits< char >::eof();
+             c = in_.get())
+        {
+            window = (window >> 8) | (static_cast< std::uint32_t >(c) << 24);
+            if (++seen >= 4 && window == detail::row_group_magic)
+                return true;
+        }
+        return false;
+    }
+
+    // Reads the group following its magic. rows are only extended when the
+    // whole group has been verified.
+    template < typename... Fields >
+    bool read_group(std::vector< type_tuple< Fields... > >& rows)
+    {
+        constexpr std::size_t header_size = 4 + 8 * sizeof...(Params);
+        header_.resize(header_size);
+        std::uint32_t checksum;
+        if (!in_.read(&header_[0], header_size)
+            || !detail::get_u32(in_, checksum)
+            || detail::fnv1a(header_.data(), header_size) != checksum)
+            return false;
+
+        const char* it = header_.data();
+        const char* last = it + header_size;
+        std::uint32_t count = 0;
+        detail::get_u32(it, last, count);
+        if (count > detail::max_group_rows)
+            return false;
+        std::vector< std::uint32_t > sizes, checksums;
+        for (std::size_t i = 0; i < sizeof...(Params); ++i)
+        {
+            std::uint32_t size = 0, sum = 0;
+            detail::get_u32(it, last, size);
+            detail::get_u32(it, last, sum);
+            if (size > detail::max_column_size)
+                return false;
+            sizes.push_back(size);
+            checksums.push_back(sum);
+        }
+
+        std::tuple< std::vector< detail::column_value< Fields > >... > columns;
+        bool ok = true;
+        std::size_t i = 0;
+        using expand = int[];
+        (void)expand{ 0,
+            (ok = ok
+                 && column< Params, Fields... >(
+                     sizes[i], checksums[i], count, columns),
+                ++i, 0)... };
+        std::uint32_t magic;
+        if (!ok || !detail::get_u32(in_, magic)
+            || magic != detail::row_group_magic)
+            return false;
+
+        rows.reserve(rows.size() + count);
+        for (std::size_t row = 0; row < count; ++row)
+        {
+            rows.emplace_back();
+            (void)expand{ 0, assign< Fields >(rows.back(), columns, row)... };
+        }
+        return true;
+    }
+
+    template < typename F, typename Row, typename Columns >
+    static int assign(Row& row, Columns& columns, std::size_t i)
+    {
+        auto& values = std::get< index_of_field< F, Row >::value >(columns);
+        row.template get< F >() = F{ std::move(values[i]) };
+        return 0;
+    }
+
+    template < typename F, typename Row > struct index_of_field;
+    template < typename F, typename... Fields >
+    struct index_of_field< F, type_tuple< Fields... > >
+        : detail::index_of< F, Fields... >
+    {
+    };
+
+    // requested column – verify and decode
+    template < typename P, typename... Fields >
+    typename std::enable_if< detail::contains< P, Fields... >::value, bool >::type
+    column(std::uint32_t size, std::uint32_t checksum, std::uint32_t count,
+        std::tuple< std::vector< detail::column_value< Fields > >... >& columns)
+    {
+        buffer_.resize(size);
+        if (!in_.read(&buffer_[0], size)
+            || detail::fnv1a(buffer_.data(), size) != checksum)
+            return false;
+
+        auto& values
+            = std::get< detail::index_of< P, Fields... >::value >(columns);
+        values.reserve(count);
+        return column_codec< detail::column_value< P > >::decode(
+            buffer_.data(), buffer_.data() + size, count, values);
+    }
+
+    // not requested column – skip, by reading when the stream can't seek
+    template < typename P, typename... Fields >
+    typename std::enable_if< !detail::contains< P, Fields... >::value, bool >::type
+    column(std::uint32_t size, std::uint32_t, std::uint32_t,
+        std::tuple< std::vector< detail::column_value< Fields > >... >&)
+    {
+        if (in_.seekg(size, std::ios_base::cur))
+            return true;
+        in_.clear();
+        return in_.ignore(size) && in_.gcount() == size;
+    }
+
+    std::istream& in_;
+    std::string header_;
+    std::string buffer_;
+};
+
+} // namespace mj
+
+#endif // jm4r_record_stream_H
@@ -7,6 +7,7 @@
 #ifndef jm4r_type_tuple_H
 #define jm4r_type_tuple_H
 
+#include <type_traits>
 #include <utility>
 
 #if __cplusplus >= 201400L
@@ -15,6 +16,16 @@
 #define MJ_CONSTEXPR14
 #endif
 
+// MJ_FORCE_INLINE_ACCESSORS – see explicit_type.hpp
+#if defined(MJ_FORCE_INLINE_ACCESSORS) \
+    && (defined(__GNUC__) || defined(__clang__))
+#define MJ_ALWAYS_INLINE inline __attribute__((always_inline, artificial))
+#elif defined(MJ_FORCE_INLINE_ACCESSORS) && defined(_MSC_VER)
+#define MJ_ALWAYS_INLINE __forceinline
+#else
+#define MJ_ALWAYS_INLINE
+#endif
+
 namespace mj
 {
 
@@ -27,16 +38,19 @@ namespace detail
 
     protected:
         constexpr property_holder() = default;
-        constexpr explicit property_holder(const value_type& val) : val_{ val }
+        MJ_ALWAYS_INLINE constexpr explicit property_holder(
+            const value_type& val)
+        : val_{ val }
         {
         }
-        constexpr explicit property_holder(value_type&& val) noexcept(
-            std::is_nothrow_move_constructible< T >::value)
+        MJ_ALWAYS_INLINE constexpr explicit property_holder(
+            value_type&& val) noexcept(std::is_nothrow_move_constructible<
+            T >::value)
         : val_{ std::move(val) }
         {
         }
-        constexpr value_type get() const { return val_; }
-        MJ_CONSTEXPR14 value_type& get() { return val_; }
+        MJ_ALWAYS_INLINE constexpr value_type get() const { return val_; }
+        MJ_ALWAYS_INLINE MJ_CONSTEXPR14 value_type& get() { return val_; }
     };
 
     template < typename T, typename... Args > struct first_type
@@ -44,6 +58,23 @@ namespace detail
         using type = T;
     };
 
+    template < typename T, typename... Ts > struct contains : std::false_type
+    {
+    };
+    template < typename T, typename U, typename... Ts >
+    struct contains< T, U, Ts... >
+        : std::integral_constant< bool,
+              std::is_same< T, U >::value || contains< T, Ts... >::value >
+    {
+    };
+
+    template < bool... > struct bool_pack
+    {
+    };
+    template < bool... Bs >
+    using all_true
+        = std::is_same< bool_pack< true, Bs... >, bool_pack< Bs..., true > >;
+
     template < typename T, typename... Args >
     using prefer_std_constructors = std::enable_if< sizeof...(Args) != 1
         || !std::is_same< T,
@@ -65,7 +96,7 @@ public:
     template < typename... Args,
         typename detail::prefer_std_constructors< type_tuple,
             Args... >::type* = nullptr >
-    constexpr explicit type_tuple(Args&&... args)
+    MJ_ALWAYS_INLINE constexpr explicit type_tuple(Args&&... args)
     : detail::property_holder< Args >(std::forward< Args >(args))...
     {
     }
@@ -78,18 +109,19 @@ public:
     constexpr type_tuple(type_tuple&&) noexcept = default;
     MJ_CONSTEXPR14 type_tuple& operator=(const type_tuple&) = default;
 
-    template < typename T > constexpr T get() const
+    template < typename T > MJ_ALWAYS_INLINE constexpr T get() const
     {
         return detail::property_holder< T >::get();
     }
-    template < typename T > MJ_CONSTEXPR14 T& get()
+    template < typename T > MJ_ALWAYS_INLINE MJ_CONSTEXPR14 T& get()
     {
         return detail::property_holder< T >::get();
     }
 
-    template < typename T > MJ_CONSTEXPR14 type_tuple& set(T&& val)
+    template < typename T >
+    MJ_ALWAYS_INLINE MJ_CONSTEXPR14 type_tuple& set(T&& val)
     {
-        get< T >() = std::forward< T >(val);
+        get< typename std::decay< T >::type >() = std::forward< T >(val);
         return *this;
     }
 
@@ -99,16 +131,70 @@ public:
         (void)expand{ 0, set_helper(std::forward< Args >(args))... };
     }
 
+    // Sets every field the other tuple has.
+    template < typename... Others >
+    MJ_CONSTEXPR14 type_tuple& merge(const type_tuple< Others... >& other)
+    {
+        static_assert(detail::all_true< detail::contains< Others,
+                          Params... >::value... >::value,
+            "merged tuple has a field that is not a field of this tuple");
+        using expand = int[];
+        (void)expand{ 0, set_helper(other.template get< Others >())... };
+        return *this;
+    }
+
+    // Copy with one field replaced, or with every field of another tuple
+    // replaced. Unlike set() and merge() it is constexpr also in C++11.
+    template < typename T > constexpr type_tuple with(const T& val) const
+    {
+        return type_tuple{ select< Params >(val, get< Params >())... };
+    }
+
 private:
-    template < typename T > MJ_CONSTEXPR14 int set_helper(T&& val)
+    template < typename T >
+    MJ_ALWAYS_INLINE MJ_CONSTEXPR14 int set_helper(T&& val)
     {
-        get< T >() = std::forward< T >(val);
+        get< typename std::decay< T >::type >() = std::forward< T >(val);
         return 0;
     }
+
+    template < typename P >
+    static constexpr P select(const P& replacement, const P&)
+    {
+        return replacement;
+    }
+    template < typename P, typename T >
+    static constexpr P select(const T&, const P& current)
+    {
+        static_assert(detail::contains< T, Params... >::value,
+            "type is not a field of this tuple");
+        return current;
+    }
+    template < typename P, typename... Others >
+    static constexpr P select(
+        const type_tuple< Others... >& other, const P& current)
+    {
+        static_assert(detail::all_true< detail::contains< Others,
+                          Params... >::value... >::value,
+            "tuple has a field that is not a field of this tuple");
+        return select_from(other, current, detail::contains< P, Others... >{});
+    }
+    template < typename P, typename Other >
+    static constexpr P select_from(const Other& other, const P&, std::true_type)
+    {
+        return other.template get< P >();
+    }
+    template < typename P, typename Other >
+    static constexpr P select_from(
+        const Other&, const P& current, std::false_type)
+    {
+        return current;
+    }
 };
 
 } // namespace mj
 
 #undef MJ_CONSTEXPR14
+#undef MJ_ALWAYS_INLINE
 
 #endif // jm4r_type_tuple_H
@@ -0,0 +1,162 @@
+// Copyright (C) 2017 - 2019 Mariusz Jaskółka.
+//
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef jm4r_type_tuple_algorithm_H
+#define jm4r_type_tuple_algorithm_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mj
+{
+
+namespace detail
+{
+    // batches smaller than this are not worth a thread of their own
+    constexpr std::size_t min_chunk_size = 4096;
+    constexpr std::size_t chunks_per_thread = 8;
+
+    inline std::size_t default_concurrency()
+    {
+        const std::size_t n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
+    // Splits [0, size) into contiguous chunks, several per thread, which
+    // threads take in turn as they become free, so a skewed part of a batch
+    // doesn't hold the others back. Returns fn(first, last) of every chunk in
+    // chunk order, so merging the results in that order gives the same answer
+    // as a sequential pass.
+    template < typename Fn >
+    auto for_each_chunk(std::size_t size, std::size_t concurrency, Fn fn)
+        -> std::vector< decltype(fn(std::size_t{}, std::size_t{})) >
+    {
+        using result_type = decltype(fn(std::size_t{}, std::size_t{}));
+
+        concurrency = std::max< std::size_t >(1, concurrency);
+        const std::size_t chunks = concurrency == 1
+            ? 1
+            : std::max< std::size_t >(1,
+                  std::min(concurrency * chunks_per_thread,
+                      size / min_chunk_size));
+        const std::size_t threads = std::min(concurrency, chunks);
+        const std::size_t chunk_size = size / chunks;
+        const std::size_t remainder = size % chunks;
+        auto chunk_first = [=](std::size_t i) -> std::size_t {
+            return i * chunk_size + std::min(i, remainder);
+        };
+
+        std::vector< result_type > results(chunks);
+        std::atomic< std::size_t > next{ 0 };
+        auto work = [&]() {
+            for (std::size_t i = next++; i < chunks; i = next++)
+                results[i] = fn(chunk_first(i), chunk_first(i + 1));
+        };
+
+        std::vector< std::future< void > > futures;
+        futures.reserve(threads - 1);
+        for (std::size_t i = 1; i < threads; ++i)
+            futures.push_back(std::async(std::launch::async, work));
+        work();
+        for (auto& f : futures)
+            f.get();
+        return results;
+    }
+}
+
+// Copies records whose Field satisfies pred, preserving their order.
+template < typename Field, typename Batch, typename Pred >
+std::vector< typename Batch::value_type > filter(const Batch& batch, Pred pred,
+    std::size_t concurrency = detail::default_concurrency())
+{
+    using record = typename Batch::value_type;
+    const auto first = std::begin(batch);
+
+    auto chunks = detail::for_each_chunk(batch.size(), concurrency,
+        [&](std::size_t from, std::size_t to) -> std::vector< record > {
+            std::vector< record > selected;
+            for (auto it = first + from; it != first + to; ++it)
+                if (pred(it->template get< Field >()))
+                    selected.push_back(*it);
+            return selected;
+        });
+
+    std::size_t total = 0;
+    for (const auto& chunk : chunks)
+        total += chunk.size();
+    std::vector< record > result;
+    result.reserve(total);
+    for (auto& chunk : chunks)
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(result));
+    return result;
+}
+
+// Groups copies of records by the value of Field. Records inside a group
+// keep their order from the batch.
+template < typename Field, typename Batch >
+std::map< Field, std::vector< typename Batch::value_type > > group_by(
+    const Batch& batch,
+    std::size_t concurrency = detail::default_concurrency())
+{
+    using groups = std::map< Field, std::vector< typename Batch::value_type > >;
+    const auto first = std::begin(batch);
+
+    auto chunks = detail::for_each_chunk(batch.size(), concurrency,
+        [&](std::size_t from, std::size_t to) -> groups {
+            groups partial;
+            for (auto it = first + from; it != first + to; ++it)
+                partial[it->template get< Field >()].push_back(*it);
+            return partial;
+        });
+
+    groups result = std::move(chunks.front());
+    for (std::size_t i = 1; i < chunks.size(); ++i)
+        for (auto& group : chunks[i])
+        {
+            auto& target = result[group.first];
+            std::move(group.second.begin(), group.second.end(),
+                std::back_inserter(target));
+        }
+    return result;
+}
+
+// Folds Field of all records with associative op. Every chunk is folded
+// separately and partial results are combined in order, so the result does
+// not depend on thread scheduling (only on concurrency for non-associative
+// operations, like floating point addition). Returns Field{} for an empty
+// batch.
+template < typename Field, typename Batch, typename Op >
+Field reduce(const Batch& batch, Op op,
+    std::size_t concurrency = detail::default_concurrency())
+{
+    if (batch.size() == 0)
+        return Field{};
+    const auto first = std::begin(batch);
+
+    auto partials = detail::for_each_chunk(batch.size(), concurrency,
+        [&](std::size_t from, std::size_t to) -> Field {
+            Field acc = (first + from)->template get< Field >();
+            for (auto it = first + from + 1; it != first + to; ++it)
+                acc = op(std::move(acc), it->template get< Field >());
+            return acc;
+        });
+
+    Field result = std::move(partials.front());
+    for (std::size_t i = 1; i < partials.size(); ++i)
+        result = op(std::move(result), std::move(partials[i]));
+    return result;
+}
+
+} // namespace mj
+
+#endif // jm4r_type_tuple_algorithm_H
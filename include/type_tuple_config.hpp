@@ -0,0 +1,169 @@
+// Copyright (C) 2017 - 2019 Mariusz Jaskółka.
+//
+// Use, modification, and distribution is subject to the Boost Software
+// License, Version 1.0. (See accompanying file LICENSE or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef jm4r_type_tuple_config_H
+#define jm4r_type_tuple_config_H
+
+#include "type_tuple.hpp"
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+// Parsing is done by C++14 constexpr functions, so a configuration embedded
+// as a string literal becomes a constant and an invalid one fails the build
+// (the throw expression can't be evaluated at compile time). At runtime
+// errors are reported by std::invalid_argument (malformed text, unknown key,
+// bad value) or std::out_of_range (number not fitting the field).
+#if __cplusplus >= 201402L
+
+namespace mj
+{
+
+// Name under which Field appears in configuration text.
+template < typename Field > struct config_key
+{
+    const char* name;
+};
+
+template < typename Field > constexpr config_key< Field > key(const char* name)
+{
+    return config_key< Field >{ name };
+}
+
+namespace detail
+{
+    struct config_text
+    {
+        const char* first;
+        const char* last;
+    };
+
+    constexpr bool is_config_separator(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ';'
+            || c == ',';
+    }
+
+    constexpr bool config_equal(config_text text, const char* str)
+    {
+        for (; text.first != text.last; ++text.first, ++str)
+            if (*str != *text.first)
+                return false;
+        return *str == '\0';
+    }
+
+    template < typename T >
+    constexpr typename std::enable_if< std::is_same< T, bool >::value, T >::type
+    parse_config_value(config_text value)
+    {
+        if (config_equal(value, "true") || config_equal(value, "1"))
+            return true;
+        if (config_equal(value, "false") || config_equal(value, "0"))
+            return false;
+        throw std::invalid_argument{ "mj::parse_config: invalid bool value" };
+    }
+
+    template < typename T >
+    constexpr typename std::enable_if< std::is_integral< T >::value
+            && !std::is_same< T, bool >::value,
+        T >::type
+    parse_config_value(config_text value)
+    {
+        const bool negative = value.first != value.last && *value.first == '-';
+        if (negative)
+            ++value.first;
+        if (value.first == value.last || (negative && std::is_unsigned< T >::value))
+            throw std::invalid_argument{ "mj::parse_config: invalid number" };
+
+        const unsigned long long limit = negative
+            ? static_cast< unsigned long long >(
+                  -(std::numeric_limits< T >::min() + 1))
+                + 1
+            : static_cast< unsigned long long >(std::numeric_limits< T >::max());
+        unsigned long long magnitude = 0;
+        for (; value.first != value.last; ++value.first)
+        {
+            const char c = *value.first;
+            if (c < '0' || c > '9')
+                throw std::invalid_argument{ "mj::parse_config: invalid number" };
+            const unsigned digit = static_cast< unsigned >(c - '0');
+            if (magnitude > (limit - digit) / 10)
+                throw std::out_of_range{ "mj::parse_config: number out of range" };
+            magnitude = magnitude * 10 + digit;
+        }
+        return negative && magnitude != 0
+            ? static_cast< T >(-static_cast< long long >(magnitude - 1) - 1)
+            : static_cast< T >(magnitude);
+    }
+
+    template < typename Tuple, typename Field >
+    constexpr bool assign_config_value(Tuple& tuple, config_text name,
+        config_text value, config_key< Field > key)
+    {
+        using value_type = typename std::remove_cv<
+            typename Field::value_type >::type;
+        static_assert(std::is_integral< value_type >::value,
+            "only integral and bool fields can be parsed");
+
+        if (!config_equal(name, key.name))
+            return false;
+        tuple.template get< Field >()
+            = Field{ parse_config_value< value_type >(value) };
+        return true;
+    }
+}
+
+// Applies "key=value" pairs separated by white spaces, ';' or ',' from text to
+// a copy of defaults. Every key has to be one of the given keys.
+template < typename Tuple, typename... Fields >
+constexpr Tuple parse_config(
+    const Tuple& defaults, const char* text, config_key< Fields >... keys)
+{
+    Tuple result = defaults;
+    const char* it = text;
+    while (true)
+    {
+        while (*it != '\0' && detail::is_config_separator(*it))
+            ++it;
+        if (*it == '\0')
+            break;
+
+        const char* name_first = it;
+        while (*it != '\0' && *it != '=' && !detail::is_config_separator(*it))
+            ++it;
+        if (*it != '=' || it == name_first)
+            throw std::invalid_argument{ "mj::parse_config: expected key=value" };
+        const detail::config_text name{ name_first, it };
+
+        const char* value_first = ++it;
+        while (*it != '\0' && !detail::is_config_separator(*it))
+            ++it;
+        const detail::config_text value{ value_first, it };
+
+        bool found = false;
+        using expand = int[];
+        (void)expand{ 0,
+            (found = detail::assign_config_value(result, name, value, keys)
+                    || found,
+                0)... };
+        if (!found)
+            throw std::invalid_argument{ "mj::parse_config: unknown key" };
+    }
+    return result;
+}
+
+template < typename Tuple, typename... Fields >
+constexpr Tuple parse_config(const char* text, config_key< Fields >... keys)
+{
+    return parse_config(Tuple{}, text, keys...);
+}
+
+} // namespace mj
+
+#endif // __cplusplus >= 201402L
+
+#endif // jm4r_type_tuple_config_H
@@ -0,0 +1,108 @@
+// Unoptimized build check and benchmark of MJ_FORCE_INLINE_ACCESSORS: the
+// same accessor-heavy loops over type_tuple and explicit_type fields and over
+// a plain struct. Build without optimizations:
+//   g++ -std=c++11 -O0 test/debug_accessors.cpp -o debug_accessors
+// and with -DMJ_NO_FORCE_INLINE_ACCESSORS for the default mode to compare.
+
+#ifndef MJ_NO_FORCE_INLINE_ACCESSORS
+#define MJ_FORCE_INLINE_ACCESSORS
+#endif
+
+#include "../include/explicit_type.hpp"
+#include "../include/type_tuple.hpp"
+#include "../bench/bench.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+
+using id = mj::explicit_type< int, struct id_tag >;
+using price = mj::explicit_type< long long, struct price_tag >;
+using quantity = mj::explicit_type< int, struct quantity_tag >;
+using order = mj::type_tuple< id, price, quantity >;
+
+struct plain_order
+{
+    int id;
+    long long price;
+    int quantity;
+};
+
+constexpr std::size_t orders = 1000000;
+
+long long total(const std::vector< order >& batch)
+{
+    long long sum = 0;
+    for (const auto& o : batch)
+        if (o.get< quantity >() > quantity{ 0 })
+            sum += *o.get< price >() * *o.get< quantity >();
+    return sum;
+}
+
+long long total(const std::vector< plain_order >& batch)
+{
+    long long sum = 0;
+    for (const auto& o : batch)
+        if (o.quantity > 0)
+            sum += o.price * o.quantity;
+    return sum;
+}
+
+void restock(std::vector< order >& batch)
+{
+    for (auto& o : batch)
+    {
+        *o.get< quantity >() += 1;
+        o.set(price{ *o.get< price >() + 1 });
+    }
+}
+
+void restock(std::vector< plain_order >& batch)
+{
+    for (auto& o : batch)
+    {
+        o.quantity += 1;
+        o.price = o.price + 1;
+    }
+}
+
+} // namespace
+
+int main()
+{
+    std::vector< order > tuples;
+    std::vector< plain_order > plains;
+    tuples.reserve(orders);
+    plains.reserve(orders);
+    for (std::size_t i = 0; i < orders; ++i)
+    {
+        const int n = static_cast< int >(i);
+        tuples.emplace_back(id{ n }, price{ n % 1000 }, quantity{ n % 7 });
+        plains.push_back(plain_order{ n, n % 1000, n % 7 });
+    }
+
+#ifdef MJ_FORCE_INLINE_ACCESSORS
+    std::printf("MJ_FORCE_INLINE_ACCESSORS defined\n");
+#else
+    std::printf("MJ_FORCE_INLINE_ACCESSORS not defined\n");
+#endif
+    bench::report("type_tuple read", bench::measure_ms([&] {
+        bench::keep(total(tuples));
+    }));
+    bench::report("plain struct read", bench::measure_ms([&] {
+        bench::keep(total(plains));
+    }));
+    bench::report("type_tuple update", bench::measure_ms([&] {
+        restock(tuples);
+    }));
+    bench::report("plain struct update", bench::measure_ms([&] {
+        restock(plains);
+    }));
+
+    assert(total(tuples) == total(plains));
+    return 0;
+}
@@ -1,11 +1,84 @@
 #include "../include/type_tuple.hpp"
 #include "../include/explicit_type.hpp"
+#include "../include/interned_string.hpp"
+#include "../include/record_stream.hpp"
+#include "../include/type_tuple_algorithm.hpp"
+#include "../include/type_tuple_config.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <limits>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
 #include <string>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+// allocations are counted only while a test enables it
+static std::atomic< bool > count_allocations{ false };
+static std::atomic< std::size_t > allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+    if (count_allocations)
+        ++allocations;
+    if (void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc{};
+}
+
+// GCC can't tell that malloc/free back the replaced operator new/delete
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace config
+{
+using use_cache = mj::explicit_type< bool, class use_cache_tag >;
+using cache_size = mj::explicit_type< int, class cache_size_tag >;
+using timeout = mj::explicit_type< long long, class timeout_tag >;
+using db_options = mj::type_tuple< use_cache, cache_size, timeout >;
+
+#if __cplusplus >= 201402L
+constexpr db_options parse(const char* text)
+{
+    return mj::parse_config< db_options >(text,
+        mj::key< use_cache >("use_cache"), mj::key< cache_size >("cache_size"),
+        mj::key< timeout >("timeout"));
+}
+
+constexpr db_options modified()
+{
+    db_options options{ cache_size{ 10 } };
+    options.set(use_cache{ true });
+    const timeout t{ -5 };
+    options.set(t);
+    options.get< cache_size >() += cache_size{ 1 };
+    options.merge(mj::type_tuple< timeout >{ timeout{ 7 } });
+    return options;
+}
+#endif
+}
 
 struct test_fixture
 {
@@ -353,6 +426,465 @@ struct test_fixture
         static_assert(sizeof(plain_data) == sizeof(tuple_data),
             "size of tuple should be the same as size of plain data struct");
     }
+
+    void test_explicit_type_heterogeneous()
+    {
+        using name = mj::explicit_type< std::string, class name_tag >;
+        const name n{ "a name that does not fit into small buffer" };
+        const char* same = "a name that does not fit into small buffer";
+        const char* other = "another name that does not fit into small buffer";
+
+        count_allocations = true;
+        std::size_t before = allocations;
+        assert(n == same);
+        assert(same == n);
+        assert(n != other);
+        assert(other != n);
+        assert(n < other);
+        assert(other > n);
+        assert(n <= same);
+        assert(same >= n);
+        assert(name{ other } > n);
+        assert(n <= name{ same });
+        assert(before + 2 == allocations);
+
+        using myint = mj::explicit_type< int, class myint_tag >;
+        assert(myint{ 3 } == 3L);
+        assert(2.5 < myint{ 3 });
+        assert(myint{ 2 } < myint{ 3 });
+        assert(myint{ 3 } >= myint{ 3 });
+        static_assert(myint{ 3 } == 3, "comparison should be constexpr");
+        // arithmetic operands are converted to value_type first
+        assert(myint{ -1 } < 1u);
+        assert(1u > myint{ -1 });
+        assert(myint{ 3 } == 3u);
+        assert(myint{ 3 } == 3.5);
+        assert(3.5 == myint{ 3 });
+        assert(!(myint{ 3 } < 3.5));
+        assert(myint{ 3 } <= 3.9);
+
+#if __cplusplus >= 201402L
+        std::map< name, int, std::less<> > ordered{ { name{ same }, 1 } };
+        before = allocations;
+        assert(1 == ordered.find(same)->second);
+        assert(ordered.end() == ordered.find(other));
+        assert(before == allocations);
+#endif
+
+        using index = std::unordered_map< name, int, mj::explicit_hash< name >,
+            mj::explicit_equal_to >;
+        index unordered{ { name{ same }, 1 } };
+        assert(1 == unordered.find(name{ same })->second);
+        assert(std::hash< name >{}(n) == mj::explicit_hash< name >{}(n));
+#if __cplusplus >= 201703L
+        const std::string_view view{ same };
+        assert(n == view);
+        assert(view == n);
+        assert(mj::explicit_hash< name >{}(view)
+            == mj::explicit_hash< name >{}(n));
+        assert(mj::explicit_equal_to{}(view, n));
+#endif
+#if defined(__cpp_lib_generic_unordered_lookup)
+        before = allocations;
+        assert(1 == unordered.find(view)->second);
+        assert(1 == unordered.count(same));
+        assert(before == allocations);
+#endif
+        count_allocations = false;
+#if defined(__cpp_impl_three_way_comparison)
+        assert((myint{ 2 } <=> myint{ 3 }) < 0);
+        assert((myint{ 3 } <=> 3) == 0);
+        assert((4 <=> myint{ 3 }) > 0);
+        assert((n <=> view) == 0);
+#endif
+    }
+
+    void test_interned_string()
+    {
+        using table_name = mj::explicit_type< mj::interned_string,
+            class table_name_tag >;
+        using tenant_id = mj::explicit_type< mj::interned_string,
+            class tenant_id_tag >;
+
+        static_assert(sizeof(table_name) == sizeof(void*),
+            "interned string should be a single pointer");
+
+        const table_name t1{ mj::interned_string{ "users" } };
+        const table_name t2{ mj::interned_string{ std::string{ "us" } + "ers" } };
+        const table_name t3{ mj::interned_string{ "orders" } };
+        assert(t1 == t2);
+        assert(t1 != t3);
+        assert(t3->str() < t1->str());
+        assert(*t3 < *t1);
+        assert(t1->c_str() == t2->c_str());
+        assert(std::string{ "users" } == t1->str());
+        assert(5 == t1->size());
+#if __cplusplus >= 201703L
+        assert("users" == t1->view());
+        assert(table_name{ mj::interned_string{ std::string_view{ "users" } } } == t1);
+#endif
+
+        const table_name empty{};
+        assert(empty->empty());
+        assert(empty == table_name{ mj::interned_string{ "" } });
+        assert(empty->str().empty());
+
+        assert(std::hash< table_name >{}(t1) == std::hash< table_name >{}(t2));
+        struct not_hashable
+        {
+        };
+        static_assert(!std::is_default_constructible< std::hash<
+                          mj::explicit_type< not_hashable, class nh_tag > > >::value,
+            "std::hash of explicit_type should be disabled like of its "
+            "value_type");
+        std::unordered_set< table_name > names{ t1, t2, t3, empty };
+        assert(3 == names.size());
+        assert(1 == names.count(t3));
+
+        mj::type_tuple< table_name, tenant_id > query{
+            tenant_id{ mj::interned_string{ "acme" } }, table_name{ t1 } };
+        assert(t1 == query.get< table_name >());
+        assert(mj::interned_string{ "acme" } == query.get< tenant_id >());
+        query.set(t3);
+        assert(t3 == query.get< table_name >());
+
+        // comparing and hashing plain strings never interns them
+        const std::size_t pooled = mj::detail::intern_table::size();
+        for (int i = 0; i < 1000; ++i)
+        {
+            const std::string id = "tenant-" + std::to_string(i);
+            assert(t1 != id.c_str());
+            assert(id != *t1);
+            assert(!(query.get< tenant_id >() == id));
+            assert(std::hash< mj::interned_string >{}(id)
+                == std::hash< mj::interned_string >{}(*empty));
+            assert(mj::explicit_hash< tenant_id >{}(id.c_str())
+                == mj::explicit_hash< tenant_id >{}(tenant_id{}));
+        }
+        assert(pooled == mj::detail::intern_table::size());
+        assert(t1 == "users");
+        assert("users" == t1);
+        assert(*t1 == std::string{ "users" });
+        assert(t3 < "users");
+        assert("users" > *t3);
+        assert(t1 <= "users" && t1 >= "users");
+        assert(t1 < "usersa" && t1 > "user");
+        assert(empty == "" && empty < "a");
+        assert(mj::explicit_equal_to{}(t1, "users"));
+        assert(std::hash< mj::interned_string >{}("users") == t1->hash());
+        assert(mj::explicit_hash< table_name >{}(std::string{ "users" })
+            == mj::explicit_hash< table_name >{}(t1));
+#if __cplusplus >= 201703L
+        assert(std::string_view{ "users" } == *t1);
+        assert(t3 < std::string_view{ "users" });
+#endif
+        assert(pooled == mj::detail::intern_table::size());
+
+        std::vector< const char* > interned(8);
+        std::vector< std::thread > threads;
+        for (std::size_t i = 0; i < interned.size(); ++i)
+            threads.emplace_back([&interned, i] {
+                interned[i] = mj::interned_string{ "concurrent" }.c_str();
+            });
+        for (auto& t : threads)
+            t.join();
+        for (auto p : interned)
+            assert(p == interned.front());
+    }
+
+    void test_algorithms()
+    {
+        using tenant_id = mj::explicit_type< int, class tenant_id_tag >;
+        using bytes_in = mj::explicit_type< long, class bytes_in_tag >;
+        using cached = mj::explicit_type< bool, class cached_tag >;
+        using request = mj::type_tuple< tenant_id, bytes_in, cached >;
+
+        std::vector< request > batch;
+        for (int i = 0; i < 50000; ++i)
+            batch.emplace_back(tenant_id{ i % 7 }, bytes_in{ i * 3L },
+                cached{ i % 5 == 0 });
+
+        std::vector< request > expected_filter;
+        std::map< tenant_id, std::vector< request > > expected_groups;
+        bytes_in expected_sum{ 0 };
+        for (const auto& r : batch)
+        {
+            if (r.get< cached >() == true)
+                expected_filter.push_back(r);
+            expected_groups[r.get< tenant_id >()].push_back(r);
+            expected_sum += r.get< bytes_in >();
+        }
+
+        auto same = [](const request& r1, const request& r2) {
+            return r1.get< tenant_id >() == r2.get< tenant_id >()
+                && r1.get< bytes_in >() == r2.get< bytes_in >()
+                && r1.get< cached >() == r2.get< cached >();
+        };
+        auto sum = [](bytes_in v1, bytes_in v2) { return v1 + v2; };
+
+        for (std::size_t threads : { 1, 2, 3, 8 })
+        {
+            auto filtered = mj::filter< cached >(
+                batch, [](cached c) { return *c; }, threads);
+            assert(filtered.size() == expected_filter.size());
+            assert(std::equal(filtered.begin(), filtered.end(),
+                expected_filter.begin(), same));
+
+            auto groups = mj::group_by< tenant_id >(batch, threads);
+            assert(groups.size() == expected_groups.size());
+            for (const auto& group : groups)
+            {
+                const auto& expected = expected_groups[group.first];
+                assert(group.second.size() == expected.size());
+                assert(std::equal(group.second.begin(), group.second.end(),
+                    expected.begin(), same));
+            }
+
+            assert(expected_sum == mj::reduce< bytes_in >(batch, sum, threads));
+        }
+
+        const std::vector< request > empty;
+        assert(mj::filter< cached >(empty, [](cached) { return true; }).empty());
+        assert(mj::group_by< tenant_id >(empty).empty());
+        assert(0 == mj::reduce< bytes_in >(empty, sum));
+    }
+
+    void test_record_stream()
+    {
+        enum class level
+        {
+            debug,
+            error
+        };
+        using id = mj::explicit_type< long long, class id_tag >;
+        using delta = mj::explicit_type< int, class delta_tag >;
+        using ok = mj::explicit_type< bool, class ok_tag >;
+        using ratio = mj::explicit_type< double, class ratio_tag >;
+        using tenant = mj::explicit_type< std::string, class tenant_tag >;
+        using severity = mj::explicit_type< level, class severity_tag >;
+        using record = mj::type_tuple< id, delta, ok, ratio, tenant, severity >;
+        using writer = mj::record_writer< record >;
+        using reader = mj::record_reader< record >;
+
+        auto make = [](int i) {
+            return record{ id{ i % 3 ? i * 1000LL
+                                     : std::numeric_limits< long long >::min() },
+                delta{ i % 2 ? -i : std::numeric_limits< int >::max() },
+                ok{ i % 3 == 0 }, ratio{ i / 4.0 },
+                tenant{ i % 4 ? "acme" : "initech" },
+                severity{ i % 5 ? level::debug : level::error } };
+        };
+
+        std::stringstream stream;
+        {
+            writer w{ stream, writer::options::row_group_size{ 100 } };
+            for (int i = 0; i < 250; ++i)
+                w.write(make(i));
+        }
+        const std::string data = stream.str();
+
+        {
+            std::stringstream in{ data };
+            reader r{ in };
+            std::vector< record > rows;
+            assert(r.read(rows) && 100 == rows.size());
+            while (r.read(rows))
+                ;
+            assert(250 == rows.size());
+            for (int i = 0; i < 250; ++i)
+            {
+                const record expected = make(i);
+                assert(expected.get< id >() == rows[i].get< id >());
+                assert(expected.get< delta >() == rows[i].get< delta >());
+                assert(expected.get< ok >() == rows[i].get< ok >());
+                assert(expected.get< ratio >() == rows[i].get< ratio >());
+                assert(expected.get< tenant >() == rows[i].get< tenant >());
+                assert(expected.get< severity >() == rows[i].get< severity >());
+            }
+        }
+
+        {
+            std::stringstream in{ data };
+            reader r{ in };
+            std::vector< mj::type_tuple< tenant, ok > > rows;
+            while (r.read(rows))
+                ;
+            assert(250 == rows.size());
+            assert("initech" == rows[0].get< tenant >());
+            assert(true == rows[3].get< ok >());
+            assert("acme" == rows[249].get< tenant >());
+        }
+
+        {
+            // crashed writer – the last row group is incomplete
+            std::stringstream in{ data.substr(0, data.size() - 10) };
+            reader r{ in };
+            std::vector< mj::type_tuple< id > > rows;
+            while (r.read(rows))
+                ;
+            assert(200 == rows.size());
+        }
+
+        // offsets of row groups: "MTRG" opens and closes each of them
+        std::vector< std::size_t > groups;
+        for (auto pos = data.find("MTRG"); pos != std::string::npos;
+             pos = data.find("MTRG", pos + 1))
+            groups.push_back(pos);
+        assert(6 == groups.size());
+        auto read_ids = [](const std::string& bytes) {
+            std::stringstream in{ bytes };
+            reader r{ in };
+            std::vector< mj::type_tuple< id, delta > > rows;
+            while (r.read(rows))
+                ;
+            return rows;
+        };
+
+        {
+            // corrupted data in the second row group – only it is lost
+            std::string corrupted = data;
+            corrupted[(groups[2] + groups[3]) / 2] ^= 0x5a;
+            auto rows = read_ids(corrupted);
+            assert(150 == rows.size());
+            assert(make(99).get< id >() == rows[99].get< id >());
+            assert(make(200).get< id >() == rows[100].get< id >());
+        }
+
+        {
+            // corrupted row count in the second row group header
+            std::string corrupted = data;
+            corrupted[groups[2] + 6] ^= 0x01;
+            auto rows = read_ids(corrupted);
+            assert(150 == rows.size());
+            assert(make(249).get< delta >() == rows.back().get< delta >());
+        }
+
+        {
+            // crashed writer, then appended by a new one
+            std::stringstream appended{ data.substr(
+                0, (groups[2] + groups[3]) / 2) };
+            appended.seekp(0, std::ios_base::end);
+            {
+                writer w{ appended, writer::options::append{ true } };
+                w.write(make(7));
+            }
+            auto rows = read_ids(appended.str());
+            assert(101 == rows.size());
+            assert(-7 == rows.back().get< delta >());
+        }
+
+        {
+            // projected read of a stream that can't seek
+            struct pipe_buf : std::streambuf
+            {
+                explicit pipe_buf(std::string& bytes)
+                {
+                    setg(&bytes[0], &bytes[0], &bytes[0] + bytes.size());
+                }
+            };
+            std::string bytes = data;
+            pipe_buf buf{ bytes };
+            std::istream in{ &buf };
+            reader r{ in };
+            std::vector< mj::type_tuple< tenant > > rows;
+            while (r.read(rows))
+                ;
+            assert(250 == rows.size());
+            assert("acme" == rows[249].get< tenant >());
+        }
+
+        {
+            std::stringstream appended{ data };
+            appended.seekp(0, std::ios_base::end);
+            writer w{ appended, writer::options::append{ true } };
+            w.write(make(7));
+            w.flush();
+
+            reader r{ appended };
+            std::vector< mj::type_tuple< delta > > rows;
+            while (r.read(rows))
+                ;
+            assert(251 == rows.size());
+            assert(-7 == rows.back().get< delta >());
+        }
+
+        {
+            std::stringstream in{ data };
+            bool thrown = false;
+            try
+            {
+                mj::record_reader< mj::type_tuple< id, delta > > r{ in };
+            }
+            catch (const std::runtime_error&)
+            {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+    }
+
+    void test_constexpr_config()
+    {
+        using namespace config;
+
+        constexpr db_options base{ cache_size{ 500 } };
+        constexpr db_options changed = base.with(use_cache{ true });
+        static_assert(changed.get< use_cache >() == true, "");
+        static_assert(changed.get< cache_size >() == 500, "");
+        constexpr db_options merged
+            = changed.with(mj::type_tuple< timeout, cache_size >{
+                cache_size{ 20 }, timeout{ 3 } });
+        static_assert(merged.get< use_cache >() == true, "");
+        static_assert(merged.get< cache_size >() == 20, "");
+        static_assert(merged.get< timeout >() == 3, "");
+
+#if __cplusplus >= 201402L
+        constexpr db_options m = modified();
+        static_assert(m.get< use_cache >() == true, "");
+        static_assert(m.get< cache_size >() == 11, "");
+        static_assert(m.get< timeout >() == 7, "");
+
+        constexpr db_options profile
+            = parse("use_cache=true; cache_size=4096\n timeout=-30");
+        static_assert(profile.get< use_cache >() == true, "");
+        static_assert(profile.get< cache_size >() == 4096, "");
+        static_assert(profile.get< timeout >() == -30, "");
+        static_assert(profile.get< cache_size >() > 0, "config validation");
+
+        constexpr db_options overridden = mj::parse_config(profile,
+            "cache_size=0,use_cache=0", mj::key< cache_size >("cache_size"),
+            mj::key< use_cache >("use_cache"));
+        static_assert(overridden.get< cache_size >() == 0, "");
+        static_assert(overridden.get< use_cache >() == false, "");
+        static_assert(overridden.get< timeout >() == -30, "");
+
+        constexpr db_options limits
+            = parse("cache_size=-2147483648 timeout=9223372036854775807");
+        static_assert(limits.get< cache_size >()
+                == std::numeric_limits< int >::min(),
+            "");
+        static_assert(limits.get< timeout >()
+                == std::numeric_limits< long long >::max(),
+            "");
+
+        assert(parse("").get< cache_size >() == 0);
+        for (const char* invalid : { "cache_size", "=1", "use_cache=yes",
+                 "cache_size=12a", "cache_size=2147483648", "size=1",
+                 "cache_size=-" })
+        {
+            bool thrown = false;
+            try
+            {
+                parse(invalid);
+            }
+            catch (const std::logic_error&)
+            {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+#endif
+    }
 };
 
 int main()
@@ -400,10 +932,15 @@ int main()
     test.test_explicit_type< throw_move >(throw_move{});
 
     test.test_explicit_type_operators();
+    test.test_explicit_type_heterogeneous();
     //---
     test.test_type_tuple();
     test.test_explicit_get_set();
     test.test_size();
+    test.test_interned_string();
+    test.test_algorithms();
+    test.test_record_stream();
+    test.test_constexpr_config();
 
     std::cout << "All tests passed" << std::endl;
 }